@@ -0,0 +1,4 @@
+let main = ping I
+let ping = \u."x" I pong u
+let pong = \u."x" I ping u
+let I = \x.x
@@ -0,0 +1,3 @@
+let main = spin I
+let spin = \u."x" I spin u
+let I = \x.x
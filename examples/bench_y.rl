@@ -0,0 +1,3 @@
+let Y = \f.(\x.x x) (\x.f(x x))
+let main = Y (\self.\u."x" I self u) I
+let I = \x.x
@@ -0,0 +1,11 @@
+let list = pair "1" (pair "2" (pair "3" nil))
+
+let main = print_all list
+
+let print_all = \xs.(is_empty xs) nil ("n" (head xs) print_all (tail xs))
+
+let pair = \x.\y.\b.b x y
+let head = \p.p (\x.\y.x)
+let tail = \p.p (\x.\y.y)
+let is_empty = \xs.xs (\h.\t.\d.nil) (\x.\y.x)
+let nil = \x.\y.y
@@ -1,5 +1,7 @@
 #include "ast.hpp"
 
+#include <stdexcept>
+
 namespace ast {
 
 bool is_variable(ExpressionPtr const& expr) { return dynamic_cast<Variable *>(expr.get()) != nullptr; }
@@ -17,4 +19,35 @@ bool is_d_app(ExpressionPtr const& expr) {
     return false;
  }
 
+ExpressionPtr make_variable(std::string name) { return std::make_unique<Variable>(std::move(name)); }
+
+ExpressionPtr make_abstraction(std::string name, ExpressionPtr body) {
+    return std::make_unique<Abstraction>(std::move(name), std::move(body));
+}
+
+ExpressionPtr make_application(ExpressionPtr lhs, ExpressionPtr rhs) {
+    return std::make_unique<Application>(std::move(lhs), std::move(rhs));
+}
+
+ExpressionPtr clone(ExpressionPtr const& expr) {
+    if (auto const *abs = dynamic_cast<Abstraction *>(expr.get())) {
+        return make_abstraction(abs->name, clone(abs->body));
+    } else if (auto const *app = dynamic_cast<Application *>(expr.get())) {
+        return make_application(clone(app->lhs), clone(app->rhs));
+    } else if (auto const *var = dynamic_cast<Variable *>(expr.get())) {
+        return make_variable(var->name);
+    } else if (auto const *str = dynamic_cast<String *>(expr.get())) {
+        return std::make_unique<String>(str->value);
+    } else if (is_s(expr)) {
+        return std::make_unique<S>();
+    } else if (is_k(expr)) {
+        return std::make_unique<K>();
+    } else if (is_i(expr)) {
+        return std::make_unique<I>();
+    } else if (is_d(expr)) {
+        return std::make_unique<D>();
+    }
+    throw std::logic_error{"Fatal error. Clone called with an unexpected node. Please report this."};
+}
+
 }  // namespace ast
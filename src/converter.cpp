@@ -1,7 +1,11 @@
 #include "converter.hpp"
 
+#include <algorithm>
 #include <functional>
+#include <limits>
+#include <string>
 #include <utility>
+#include <vector>
 
 namespace {
 
@@ -44,11 +48,51 @@ bool is_pure(ast::ExpressionPtr const& expr) {
 }
 
 ast::ExpressionPtr apply(ast::ExpressionPtr x, ast::ExpressionPtr y) {
-    return std::make_unique<ast::Application>(std::move(x), std::move(y));
+    return ast::make_application(std::move(x), std::move(y));
 }
 
 ast::ExpressionPtr apply_d(ast::ExpressionPtr x) { return apply(std::make_unique<ast::D>(), std::move(x)); }
 
+// Replaces free mentions of `name` with copies of `value`.
+ast::ExpressionPtr substitute(ast::ExpressionPtr expr, std::string const& name, ast::ExpressionPtr const& value) {
+    if (auto *abs = dynamic_cast<ast::Abstraction *>(expr.get())) {
+        if (abs->name != name) {
+            abs->body = substitute(std::move(abs->body), name, value);
+        }
+    } else if (auto *app = dynamic_cast<ast::Application *>(expr.get())) {
+        app->lhs = substitute(std::move(app->lhs), name, value);
+        app->rhs = substitute(std::move(app->rhs), name, value);
+    } else if (auto *var = dynamic_cast<ast::Variable *>(expr.get())) {
+        if (var->name == name) {
+            return ast::clone(value);
+        }
+    }
+    return expr;
+}
+
+// Gives every parameter a fresh name which can't appear in the source, so that inlining an expression into another
+// can't capture the definitions it mentions. `scope` maps the original names to the fresh ones.
+ast::ExpressionPtr freshen(ast::ExpressionPtr expr, std::vector<std::pair<std::string, std::string>>& scope,
+                           std::size_t& counter) {
+    if (auto *abs = dynamic_cast<ast::Abstraction *>(expr.get())) {
+        scope.emplace_back(abs->name, '$' + std::to_string(counter++));
+        abs->body = freshen(std::move(abs->body), scope, counter);
+        abs->name = scope.back().second;
+        scope.pop_back();
+    } else if (auto *app = dynamic_cast<ast::Application *>(expr.get())) {
+        app->lhs = freshen(std::move(app->lhs), scope, counter);
+        app->rhs = freshen(std::move(app->rhs), scope, counter);
+    } else if (auto *var = dynamic_cast<ast::Variable *>(expr.get())) {
+        for (auto it = scope.rbegin(); it != scope.rend(); ++it) {
+            if (it->first == var->name) {
+                var->name = it->second;
+                break;
+            }
+        }
+    }
+    return expr;
+}
+
 ast::ExpressionPtr preprocess(ast::ExpressionPtr expr) {
     if (is_abstraction(expr)) {
         auto& abs = static_cast<ast::Abstraction&>(*expr);
@@ -72,6 +116,17 @@ ast::ExpressionPtr preprocess(ast::ExpressionPtr expr) {
     }
 }
 
+// `S I I W` where `W = \$f.\_.E I` and `E` is the preprocessed `body` with every mention of `name` replaced by `$f $f`.
+// Evaluates to the thunk which `body` stands for when `name` is defined as `body`. `S I I` applies `W` to itself, so
+// the code of `W` only appears once.
+ast::ExpressionPtr fixpoint(std::string const& name, ast::ExpressionPtr body) {
+    std::string self = '$' + name;
+    body = substitute(std::move(body), name, apply(ast::make_variable(self), ast::make_variable(self)));
+    auto thunk = ast::make_abstraction("_", apply(std::move(body), std::make_unique<ast::I>()));
+    auto sii = apply(apply(std::make_unique<ast::S>(), std::make_unique<ast::I>()), std::make_unique<ast::I>());
+    return apply(std::move(sii), ast::make_abstraction(self, std::move(thunk)));
+}
+
 namespace transformations {
 
 ast::ExpressionPtr transform(ast::ExpressionPtr expr);
@@ -205,3 +260,103 @@ ast::ExpressionPtr conv::to_ski(ast::ExpressionPtr expr) {
     // throw 0;
     return transformations::transform(preprocess(std::move(expr)));
 }
+
+ast::Definitions conv::to_ski(ast::Definitions defs) {
+    for (std::vector<std::size_t> const& group : dependency_groups(defs)) {
+        ast::Definition& first = defs[group.front()];
+        if (group.size() == 1 && !mentions(first.value, first.name)) {
+            first.value = to_ski(std::move(first.value));
+            continue;
+        }
+
+        ast::Definitions recursive;
+        for (std::size_t i : group) {
+            recursive.push_back(std::move(defs[i]));
+        }
+        recursive = to_ski_recursive(std::move(recursive));
+        for (std::size_t i = 0; i < group.size(); ++i) {
+            defs[group[i]] = std::move(recursive[i]);
+        }
+    }
+    return defs;
+}
+
+// Tarjan's algorithm, which emits every component after the components it reaches.
+std::vector<std::vector<std::size_t>> conv::dependency_groups(ast::Definitions const& defs) {
+    constexpr std::size_t unvisited = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> order(defs.size(), unvisited);
+    std::vector<std::size_t> low(defs.size());
+    std::vector<bool> on_stack(defs.size());
+    std::vector<std::size_t> stack;
+    std::vector<std::vector<std::size_t>> groups;
+    std::size_t counter = 0;
+
+    auto visit = [&](auto& self, std::size_t v) -> void {
+        order[v] = low[v] = counter++;
+        stack.push_back(v);
+        on_stack[v] = true;
+        for (std::size_t w = 0; w < defs.size(); ++w) {
+            if (!mentions(defs[v].value, defs[w].name)) {
+                continue;
+            }
+            if (order[w] == unvisited) {
+                self(self, w);
+                low[v] = std::min(low[v], low[w]);
+            } else if (on_stack[w]) {
+                low[v] = std::min(low[v], order[w]);
+            }
+        }
+        if (low[v] == order[v]) {
+            std::vector<std::size_t> group;
+            std::size_t w;
+            do {
+                w = stack.back();
+                stack.pop_back();
+                on_stack[w] = false;
+                group.push_back(w);
+            } while (w != v);
+            std::ranges::sort(group);
+            groups.push_back(std::move(group));
+        }
+    };
+
+    for (std::size_t i = 0; i < defs.size(); ++i) {
+        if (order[i] == unvisited) {
+            visit(visit, i);
+        }
+    }
+    return groups;
+}
+
+ast::Definitions conv::to_ski_recursive(ast::Definitions group) {
+    // The group is reduced to a single self-recursive definition (Bekić's theorem). Every other member is inlined into
+    // the ones which are still left, so a call only goes through the fixpoint of the first member. A member which still
+    // mentions itself when it is inlined gets its own fixpoint. See safe_operations.md for the exact rules.
+    std::size_t counter = 0;
+    std::vector<ast::ExpressionPtr> bodies;
+    for (ast::Definition& def : group) {
+        std::vector<std::pair<std::string, std::string>> scope;
+        bodies.push_back(preprocess(freshen(std::move(def.value), scope, counter)));
+    }
+
+    for (std::size_t i = 1; i < group.size(); ++i) {
+        std::string const& name = group[i].name;
+        ast::ExpressionPtr inlined = ast::clone(bodies[i]);
+        if (mentions(inlined, name)) {
+            inlined = fixpoint(name, std::move(inlined));
+        }
+        bodies[0] = substitute(std::move(bodies[0]), name, inlined);
+        for (std::size_t j = i + 1; j < group.size(); ++j) {
+            bodies[j] = substitute(std::move(bodies[j]), name, inlined);
+        }
+    }
+
+    // The other members are defined from the fixpoint, by name.
+    for (std::size_t i = 0; i < group.size(); ++i) {
+        if (mentions(bodies[i], group[i].name)) {
+            bodies[i] = fixpoint(group[i].name, std::move(bodies[i]));
+        }
+        group[i].value = transformations::transform(std::move(bodies[i]));
+    }
+    return group;
+}
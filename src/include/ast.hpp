@@ -122,6 +122,13 @@ struct D : Expression {
     std::string format_unlambda(Definitions const&) const noexcept override { return "d"; }
 };
 
+ExpressionPtr make_variable(std::string name);
+ExpressionPtr make_abstraction(std::string name, ExpressionPtr body);
+ExpressionPtr make_application(ExpressionPtr lhs, ExpressionPtr rhs);
+
+/// @brief Deep copy of any expression, including combinators.
+ExpressionPtr clone(ExpressionPtr const& expr);
+
 }  // namespace ast
 
 #endif
@@ -1,12 +1,28 @@
 #ifndef CONVERTER_HPP
 #define CONVERTER_HPP
 
+#include <cstddef>
+#include <vector>
+
 #include "ast.hpp"
 
 namespace conv {
 
 ast::ExpressionPtr to_ski(ast::ExpressionPtr expr);
 
+/// @brief Converts every definition. Groups of definitions which mention each other are converted together with
+/// to_ski_recursive, everything else with to_ski.
+ast::Definitions to_ski(ast::Definitions defs);
+
+/// @brief Splits definitions into groups which mention each other (strongly connected components).
+/// @return Indices into `defs` in source order, where each group comes after the groups it depends on.
+std::vector<std::vector<std::size_t>> dependency_groups(ast::Definitions const& defs);
+
+/// @brief Converts a group of definitions which mention each other (or a single definition which mentions itself).
+/// @return The same definitions. The first one no longer mentions any name from the group, every other one only mentions
+/// the first one and those after it.
+ast::Definitions to_ski_recursive(ast::Definitions group);
+
 }
 
 #endif
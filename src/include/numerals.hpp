@@ -0,0 +1,15 @@
+#ifndef NUMERALS_HPP
+#define NUMERALS_HPP
+
+#include "ast.hpp"
+
+namespace num {
+
+/// @brief Replaces every definition which normalizes to a Church numeral with a compact equivalent, unless the
+/// definition as written converts to less code.
+/// Definitions which mention strings, recurse, or don't normalize within a fixed budget are left untouched.
+void fold_numerals(ast::Definitions& defs);
+
+}  // namespace num
+
+#endif
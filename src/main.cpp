@@ -2,6 +2,7 @@
 #include <iostream>
 
 #include "converter.hpp"
+#include "numerals.hpp"
 #include "parser.hpp"
 
 // for validation
@@ -52,7 +53,6 @@ std::optional<std::string> translate(ast::Definitions&& defs, bool do_ski) {
             std::cerr << "multiple definitions for \"" << def.name << "\" detected.\n";
             return std::nullopt;
         }
-        def.value = conv::to_ski(std::move(def.value));
     }
 
     bool really_bad = false;
@@ -62,10 +62,6 @@ std::optional<std::string> translate(ast::Definitions&& defs, bool do_ski) {
                 std::cerr << "undefined name: " << name << '\n';
                 really_bad = true;
             }
-            if (name == def_name) {
-                std::cerr << "circular dependencies not yet allowed for: " << name << '\n';
-                really_bad = true;
-            }
         }
     }
 
@@ -73,6 +69,9 @@ std::optional<std::string> translate(ast::Definitions&& defs, bool do_ski) {
         return std::nullopt;
     }
 
+    num::fold_numerals(defs);
+    defs = conv::to_ski(std::move(defs));
+
     auto it = std::ranges::find_if(defs, [](ast::Definition const& x) { return x.name == "main"; });
     if (it == defs.end()) {
         std::cerr << "no main detected\n";
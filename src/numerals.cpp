@@ -0,0 +1,338 @@
+#include "numerals.hpp"
+
+#include "converter.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Lambda terms in de Bruijn notation, so that definitions can be inlined without renaming.
+struct Term;
+using TermPtr = std::shared_ptr<Term const>;
+
+struct Term {
+    enum class Kind { variable, abstraction, application };
+
+    Kind kind;
+    std::size_t index;  // variables only
+    TermPtr lhs;        // abstraction body or application lhs
+    TermPtr rhs;        // application rhs
+    std::size_t size;
+};
+
+// Evaluation budget for a single definition. Anything more expensive is left for the runtime.
+constexpr std::size_t max_steps = 100'000;
+constexpr std::size_t max_size = 10'000;
+constexpr std::size_t max_nesting = 2'000;
+
+// Unary forms grow linearly, so they are only compared against the compact ones for small counts.
+constexpr std::size_t max_unary = 16;
+
+struct out_of_budget {};
+
+TermPtr make_variable(std::size_t index) {
+    return std::make_shared<Term const>(Term{Term::Kind::variable, index, nullptr, nullptr, 1});
+}
+
+TermPtr make_abstraction(TermPtr body) {
+    std::size_t size = body->size + 1;
+    return std::make_shared<Term const>(Term{Term::Kind::abstraction, 0, std::move(body), nullptr, size});
+}
+
+TermPtr make_application(TermPtr lhs, TermPtr rhs) {
+    std::size_t size = lhs->size + rhs->size + 1;
+    return std::make_shared<Term const>(Term{Term::Kind::application, 0, std::move(lhs), std::move(rhs), size});
+}
+
+// Terms are evaluated to closures. Arguments are passed as memoized thunks, so evaluation terminates whenever
+// normal order reduction would.
+struct Value;
+struct Thunk;
+
+struct Env {
+    Thunk *head;
+    Env const *tail;
+};
+
+struct Thunk {
+    Term const *term;
+    Env const *env;
+    Value const *value;
+};
+
+// Either a closure, or a free variable (identified by its de Bruijn level) applied to the spine.
+struct Value {
+    Term const *body;
+    Env const *env;
+    std::size_t level;
+    std::vector<Thunk *> spine;
+};
+
+struct Evaluator {
+    std::size_t steps = 0;
+    std::size_t nesting = 0;
+
+    // Nodes live as long as the evaluator and only point at each other, so long chains of them are released
+    // without recursing through their destructors.
+    std::vector<std::unique_ptr<Env const>> envs;
+    std::vector<std::unique_ptr<Thunk>> thunks;
+    std::vector<std::unique_ptr<Value const>> values;
+
+    Env const *make_env(Thunk *head, Env const *tail) {
+        return envs.emplace_back(std::make_unique<Env const>(Env{head, tail})).get();
+    }
+
+    Thunk *make_thunk(Term const *term, Env const *env, Value const *value) {
+        return thunks.emplace_back(std::make_unique<Thunk>(Thunk{term, env, value})).get();
+    }
+
+    Value const *make_value(Term const *body, Env const *env, std::size_t level, std::vector<Thunk *> spine) {
+        return values.emplace_back(std::make_unique<Value const>(Value{body, env, level, std::move(spine)})).get();
+    }
+
+    Value const *force(Thunk& thunk) {
+        if (!thunk.value) {
+            thunk.value = eval(thunk.term, thunk.env);
+            thunk.env = nullptr;
+        }
+        return thunk.value;
+    }
+
+    Value const *eval(Term const *term, Env const *env) {
+        switch (term->kind) {
+            case Term::Kind::variable:
+                for (std::size_t i = 0; i < term->index; ++i) {
+                    env = env->tail;
+                }
+                return force(*env->head);
+            case Term::Kind::abstraction:
+                return make_value(term->lhs.get(), env, 0, {});
+            case Term::Kind::application:
+                return apply(eval(term->lhs.get(), env), make_thunk(term->rhs.get(), env, nullptr));
+        }
+        std::unreachable();
+    }
+
+    Value const *apply(Value const *fun, Thunk *arg) {
+        if (fun->body) {
+            if (++steps > max_steps || ++nesting > max_nesting) {
+                throw out_of_budget{};
+            }
+            auto res = eval(fun->body, make_env(arg, fun->env));
+            --nesting;
+            return res;
+        }
+        auto spine = fun->spine;
+        spine.push_back(arg);
+        return make_value(nullptr, nullptr, fun->level, std::move(spine));
+    }
+
+    // Counts the applications of `f` in `\f.\x.f (f (... x))`. The value is applied to two free variables and the
+    // result is walked one application at a time, so the numeral is never read back as a whole.
+    std::optional<std::size_t> church_value(Value const *value) {
+        for (std::size_t level = 0; level < 2; ++level) {
+            if (!value->body) {
+                return std::nullopt;
+            }
+            value = apply(value, make_thunk(nullptr, nullptr, make_value(nullptr, nullptr, level, {})));
+        }
+
+        std::size_t count = 0;
+        while (!value->body && value->level == 0 && value->spine.size() == 1) {
+            if (++steps > max_steps) {
+                throw out_of_budget{};
+            }
+            ++count;
+            value = force(*value->spine.front());
+        }
+        if (!value->body && value->level == 1 && value->spine.empty()) {
+            return count;
+        }
+        return std::nullopt;
+    }
+};
+
+// Converts a definition body to a closed term by inlining the definitions it mentions.
+// Fails on strings (they have side-effects), undefined names and recursion.
+TermPtr lower(ast::ExpressionPtr const& expr, std::vector<std::string>& scope, ast::Definitions const& defs,
+              std::vector<std::string>& visiting) {
+    if (auto const *var = dynamic_cast<ast::Variable const *>(expr.get())) {
+        for (std::size_t i = scope.size(); i-- > 0;) {
+            if (scope[i] == var->name) {
+                return make_variable(scope.size() - 1 - i);
+            }
+        }
+
+        auto def = std::ranges::find_if(defs, [var](ast::Definition const& def) { return def.name == var->name; });
+        if (def == defs.end() || std::ranges::find(visiting, var->name) != visiting.end()) {
+            return nullptr;
+        }
+        visiting.push_back(var->name);
+        std::vector<std::string> def_scope;
+        auto res = lower(def->value, def_scope, defs, visiting);
+        visiting.pop_back();
+        return res;
+    } else if (auto const *abs = dynamic_cast<ast::Abstraction const *>(expr.get())) {
+        scope.push_back(abs->name);
+        auto body = lower(abs->body, scope, defs, visiting);
+        scope.pop_back();
+        return body ? make_abstraction(std::move(body)) : nullptr;
+    } else if (auto const *app = dynamic_cast<ast::Application const *>(expr.get())) {
+        auto lhs = lower(app->lhs, scope, defs, visiting);
+        auto rhs = lhs ? lower(app->rhs, scope, defs, visiting) : nullptr;
+        if (!rhs || lhs->size + rhs->size >= max_size) {
+            return nullptr;
+        }
+        return make_application(std::move(lhs), std::move(rhs));
+    } else {
+        return nullptr;
+    }
+}
+
+// f (f (... x)) with n applications of f
+ast::ExpressionPtr unary(std::size_t n, std::string const& f, std::string const& x) {
+    auto res = ast::make_variable(x);
+    for (std::size_t i = 0; i < n; ++i) {
+        res = ast::make_application(ast::make_variable(f), std::move(res));
+    }
+    return res;
+}
+
+// Length of the unlambda code which a closed expression is converted to.
+std::size_t converted_size(ast::ExpressionPtr expr) {
+    return conv::to_ski(std::move(expr))->format_unlambda({}).size();
+}
+
+// Returns whichever of the two functions of g converts to less code, preferring the unary one on ties.
+ast::ExpressionPtr smaller(ast::ExpressionPtr compact, ast::ExpressionPtr unary, std::string const& g) {
+    if (converted_size(ast::make_abstraction(g, ast::clone(unary))) <=
+        converted_size(ast::make_abstraction(g, ast::clone(compact)))) {
+        return unary;
+    }
+    return compact;
+}
+
+// Function which applies g n times, where n > 0. Even counts square g and halve n, so the size of the
+// result grows with the number of bits in n instead of with n itself.
+ast::ExpressionPtr compose(std::size_t n, std::string const& g, std::size_t depth) {
+    if (n == 1) {
+        return ast::make_variable(g);
+    }
+    ast::ExpressionPtr res;
+    if (n % 2 == 1) {
+        auto rest = ast::make_application(compose(n - 1, g, depth), ast::make_variable("y"));
+        res = ast::make_abstraction("y", ast::make_application(ast::make_variable(g), std::move(rest)));
+    } else {
+        std::string h = "f" + std::to_string(depth + 1);
+        res = ast::make_application(ast::make_abstraction(h, compose(n / 2, h, depth + 1)),
+                                    ast::make_abstraction("y", unary(2, g, "y")));
+    }
+    if (n <= max_unary) {
+        res = smaller(std::move(res), ast::make_abstraction("y", unary(n, g, "y")), g);
+    }
+    return res;
+}
+
+ast::ExpressionPtr make_numeral(std::size_t n) {
+    if (n == 0) {
+        return ast::make_abstraction("f0", ast::make_abstraction("x", ast::make_variable("x")));
+    }
+    auto res = ast::make_abstraction("x", ast::make_application(compose(n, "f0", 0), ast::make_variable("x")));
+    if (n <= max_unary) {
+        res = smaller(std::move(res), ast::make_abstraction("x", unary(n, "f0", "x")), "f0");
+    }
+    return ast::make_abstraction("f0", std::move(res));
+}
+
+// Indices of the definitions which `expr` mentions.
+std::vector<std::size_t> dependencies(ast::ExpressionPtr const& expr, std::vector<std::string>& scope,
+                                      ast::Definitions const& defs) {
+    if (auto const *var = dynamic_cast<ast::Variable const *>(expr.get())) {
+        auto def = std::ranges::find_if(defs, [var](ast::Definition const& def) { return def.name == var->name; });
+        if (std::ranges::find(scope, var->name) != scope.end() || def == defs.end()) {
+            return {};
+        }
+        return {static_cast<std::size_t>(def - defs.begin())};
+    } else if (auto const *abs = dynamic_cast<ast::Abstraction const *>(expr.get())) {
+        scope.push_back(abs->name);
+        auto res = dependencies(abs->body, scope, defs);
+        scope.pop_back();
+        return res;
+    } else if (auto const *app = dynamic_cast<ast::Application const *>(expr.get())) {
+        auto res = dependencies(app->lhs, scope, defs);
+        auto rhs = dependencies(app->rhs, scope, defs);
+        res.insert(res.end(), rhs.begin(), rhs.end());
+        return res;
+    }
+    return {};
+}
+
+// Length of what format_unlambda produces for a converted expression, where `sizes` holds the lengths of the
+// definitions it inlines. Counted instead of formatted since inlining can repeat a definition many times.
+std::size_t unlambda_size(ast::ExpressionPtr const& expr, ast::Definitions const& defs,
+                          std::vector<std::optional<std::size_t>> const& sizes) {
+    if (auto const *var = dynamic_cast<ast::Variable const *>(expr.get())) {
+        auto def = std::ranges::find_if(defs, [var](ast::Definition const& def) { return def.name == var->name; });
+        return *sizes[static_cast<std::size_t>(def - defs.begin())];
+    } else if (auto const *app = dynamic_cast<ast::Application const *>(expr.get())) {
+        return 1 + unlambda_size(app->lhs, defs, sizes) + unlambda_size(app->rhs, defs, sizes);
+    } else if (auto const *str = dynamic_cast<ast::String const *>(expr.get())) {
+        return 1 + str->value.size();
+    }
+    return 1;
+}
+
+}  // namespace
+
+void num::fold_numerals(ast::Definitions& defs) {
+    // Evaluate everything first so that each definition is folded using the original source.
+    std::vector<std::optional<std::size_t>> values;
+    values.reserve(defs.size());
+    for (ast::Definition const& def : defs) {
+        std::vector<std::string> scope;
+        std::vector<std::string> visiting{def.name};
+        auto term = lower(def.value, scope, defs, visiting);
+        std::optional<std::size_t> value;
+        if (term) {
+            try {
+                Evaluator evaluator;
+                value = evaluator.church_value(evaluator.eval(term.get(), nullptr));
+            } catch (out_of_budget const&) {
+            }
+        }
+        values.push_back(value);
+    }
+
+    // A numeral is only folded when that formats to less code than the definition as written, with the definitions
+    // it mentions inlined in their final form. Those are measured first, so `finish` recurses into them.
+    std::vector<std::optional<std::size_t>> sizes(defs.size());
+    auto finish = [&](auto& self, std::size_t i) -> void {
+        if (sizes[i]) {
+            return;
+        }
+        std::vector<std::string> scope;
+        for (std::size_t dep : dependencies(defs[i].value, scope, defs)) {
+            self(self, dep);
+        }
+        sizes[i] = unlambda_size(conv::to_ski(ast::clone(defs[i].value)), defs, sizes);
+        if (values[i]) {
+            auto numeral = make_numeral(*values[i]);
+            std::size_t size = converted_size(ast::clone(numeral));
+            if (size < *sizes[i]) {
+                defs[i].value = std::move(numeral);
+                sizes[i] = size;
+            }
+        }
+    };
+    for (std::size_t i = 0; i < defs.size(); ++i) {
+        if (values[i]) {
+            finish(finish, i);
+        }
+    }
+}
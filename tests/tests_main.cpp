@@ -2,8 +2,11 @@
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "converter.hpp"
+#include "numerals.hpp"
 #include "parser.hpp"
 
 std::string parse(std::string_view src) {
@@ -23,6 +26,40 @@ std::string convert(std::string_view src) {
     return (*res)->format();
 }
 
+ast::Definitions parse_definitions(std::vector<std::pair<std::string, std::string_view>> const& sources) {
+    ast::Definitions defs;
+    for (auto const& [name, src] : sources) {
+        std::optional<ast::ExpressionPtr> res = parser::parse_string_expression(src);
+        if (!res) {
+            throw std::runtime_error{"parsing failed"};
+        }
+        defs.push_back({name, *std::move(res)});
+    }
+    return defs;
+}
+
+// folds `src` next to the definitions from examples/nums.rl
+std::string fold(std::string_view src) {
+    ast::Definitions defs = parse_definitions({
+        {"zero", "\\f.\\x.x"},
+        {"inc", "\\num.\\f.\\x.f (num f x)"},
+        {"add", "\\a.\\b.a inc b"},
+        {"multiply", "\\a.\\b.b (add a) zero"},
+        {"pow", "\\a.\\b.b a"},
+        {"main", src},
+    });
+    num::fold_numerals(defs);
+    return defs.back().value->format();
+}
+
+std::vector<std::string> convert_recursive(std::vector<std::pair<std::string, std::string_view>> const& sources) {
+    std::vector<std::string> res;
+    for (ast::Definition const& def : conv::to_ski_recursive(parse_definitions(sources))) {
+        res.push_back(def.value->format());
+    }
+    return res;
+}
+
 TEST_CASE("Expression parsing", "[expression]") {
     REQUIRE(parse("x x") == "x x");
     REQUIRE(parse("x ( x  x ) ") == "x (x x)");
@@ -42,6 +79,115 @@ TEST_CASE("Expression parsing", "[expression]") {
     REQUIRE(parse(R"("Aa1_=+@`\\\n\"")") == "\"Aa1_=+@`\\\n\"\"");
 }
 
+TEST_CASE("Numeral folding", "[numerals]") {
+    REQUIRE(fold("inc (inc zero)") == "\\f0.\\x.f0 (f0 x)");
+    REQUIRE(fold("multiply (inc (inc zero)) (inc (inc (inc (inc zero))))") ==
+            "\\f0.\\x.(\\f1.\\y.f1 (f1 (f1 (f1 y)))) (\\y.f0 (f0 y)) x");
+    REQUIRE(fold("pow (inc (inc zero)) (inc (inc (inc zero)))") ==
+            "\\f0.\\x.(\\f1.\\y.f1 (f1 (f1 (f1 y)))) (\\y.f0 (f0 y)) x");
+    // small numerals are shorter in unary
+    REQUIRE(fold("add (inc (inc zero)) (inc (inc (inc zero)))") == "\\f0.\\x.f0 (f0 (f0 (f0 (f0 x))))");
+    // 4096, too large to be read back as a unary numeral
+    REQUIRE(fold("pow (inc (inc zero)) (multiply (inc (inc (inc zero))) (inc (inc (inc (inc zero)))))") ==
+            "\\f0.\\x.(\\f1.(\\f2.(\\f3.(\\f4.(\\f5.(\\f6.(\\f7.(\\f8.(\\f9.(\\f10.\\y.f10 (f10 (f10 (f10 y)))) "
+            "(\\y.f9 (f9 y))) (\\y.f8 (f8 y))) (\\y.f7 (f7 y))) (\\y.f6 (f6 y))) (\\y.f5 (f5 y))) (\\y.f4 (f4 y))) "
+            "(\\y.f3 (f3 y))) (\\y.f2 (f2 y))) (\\y.f1 (f1 y))) (\\y.f0 (f0 y)) x");
+
+    // already at least as small as written
+    REQUIRE(fold("zero") == "zero");
+    REQUIRE(fold("\\f.\\x.f (f (f (f x)))") == "\\f.\\x.f (f (f (f x)))");
+    // not numerals, impure, recursive or too expensive to evaluate
+    REQUIRE(fold("add zero") == "add zero");
+    REQUIRE(fold("inc (inc zero) \"a\"") == "inc (inc zero) \"a\"");
+    REQUIRE(fold("inc main") == "inc main");
+    REQUIRE(fold("(\\x.x x) (\\x.x x)") == "(\\x.x x) (\\x.x x)");
+
+    // runs out of budget after building long chains of thunks, which used to overflow the stack when released
+    ast::Definitions defs = parse_definitions({
+        {"zero", "\\f.\\x.x"},
+        {"inc", "\\num.\\f.\\x.f (num f x)"},
+        {"add", "\\a.\\b.a inc b"},
+        {"pow", "\\a.\\b.b a"},
+        {"two", "inc (inc zero)"},
+        {"four", "two two"},
+        {"W", "\\k.\\x.k (k x)"},
+        {"Ii", "\\x.x"},
+        {"main", "Ii (inc add) (zero (\\x.x x) (four W)) add pow"},
+    });
+    num::fold_numerals(defs);
+    REQUIRE(defs.back().value->format() == "Ii (inc add) (zero (\\x.x x) (four W)) add pow");
+
+    // 1024 is shorter as written when two and ten are named, ten itself is not
+    defs = parse_definitions({
+        {"zero", "\\f.\\x.x"},
+        {"inc", "\\num.\\f.\\x.f (num f x)"},
+        {"add", "\\a.\\b.a inc b"},
+        {"pow", "\\a.\\b.b a"},
+        {"two", "inc (inc zero)"},
+        {"five", "add two (inc two)"},
+        {"ten", "add five five"},
+        {"main", "pow two ten"},
+    });
+    num::fold_numerals(defs);
+    REQUIRE(defs.back().value->format() == "pow two ten");
+    REQUIRE(defs[6].value->format() == "\\f0.\\x.(\\f1.\\y.f1 (f1 (f1 (f1 (f1 y))))) (\\y.f0 (f0 y)) x");
+}
+
+TEST_CASE("Dependency groups", "[recursion]") {
+    using Groups = std::vector<std::vector<std::size_t>>;
+    auto groups = [](std::vector<std::pair<std::string, std::string_view>> const& sources) {
+        return conv::dependency_groups(parse_definitions(sources));
+    };
+
+    REQUIRE(groups({{"f", "\\x.f x"}, {"g", "\\g.g"}}) == Groups{{0}, {1}});
+    REQUIRE(groups({{"a", "\\x.b x"}, {"b", "\\x.a x"}}) == Groups{{0, 1}});
+    REQUIRE(groups({{"a", "\\x.b x"}, {"b", "\\x.c x"}, {"c", "\\x.a x"}}) == Groups{{0, 1, 2}});
+    REQUIRE(groups({{"f", "g"}, {"g", "\\u.\"x\" f u"}}) == Groups{{0, 1}});
+    REQUIRE(groups({{"main", "f I"}, {"f", "g"}, {"g", "\\u.\"x\" f u"}, {"I", "\\x.x"}}) ==
+            Groups{{1, 2}, {3}, {0}});
+
+    // only the cycle gets a fixpoint, main keeps mentioning it
+    ast::Definitions defs = conv::to_ski(
+        parse_definitions({{"main", "f I"}, {"f", "g"}, {"g", "\\u.\"x\" f u"}, {"I", "\\x.x"}}));
+    REQUIRE(defs[0].value->format() == convert("f I"));
+    REQUIRE(defs[1].value->format().find_first_of("fg") == std::string::npos);
+    REQUIRE(defs[2].value->format() == convert("\\u.\"x\" f u"));
+    REQUIRE(defs[3].value->format() == convert("\\x.x"));
+}
+
+TEST_CASE("Recursive definitions", "[recursion]") {
+    REQUIRE(convert_recursive({{"f", "f"}}) == std::vector<std::string>{"S I I (S (K D) (S (K K) (S (S I I) (K I))))"});
+
+    // parameters shadow the definition
+    REQUIRE(convert_recursive({{"f", "\\f.f"}}) == std::vector<std::string>{convert("\\f.f")});
+    REQUIRE(convert_recursive({{"f", "\\x.f (\\f.f)"}}) == convert_recursive({{"f", "\\x.f (\\g.g)"}}));
+    REQUIRE(convert_recursive({{"f", "\\x.f (\\f.f)"}}) != convert_recursive({{"f", "\\x.f (\\g.f)"}}));
+
+    // names outside of the group are left for formatting to inline
+    REQUIRE(convert_recursive({{"f", "g f"}}) ==
+            std::vector<std::string>{
+                "S I I (S (K D) (S (K K) (S (S (K D) (S (K K) (S (S (D (K (g I))) (S I I)) (K I)))) (K I))))"});
+
+    // odd is inlined into even, and then defined from it
+    auto mutual = convert_recursive({{"even", "\\x.odd (g x)"}, {"odd", "\\x.even x"}});
+    REQUIRE(mutual.size() == 2);
+    REQUIRE(mutual[0].find("even") == std::string::npos);
+    REQUIRE(mutual[0].find("odd") == std::string::npos);
+    REQUIRE(mutual[0].find("(g I)") != std::string::npos);
+    REQUIRE(mutual[1] == convert("\\x.even x"));
+
+    // inlining pong into ping doesn't capture the definition u
+    auto captured = convert_recursive({{"ping", "\\u.pong u"}, {"pong", "\\x.u (ping x)"}});
+    REQUIRE(captured[0].find('u') != std::string::npos);
+
+    // c mentions itself once b is inlined into it, so it gets its own fixpoint inside of a
+    auto nested = convert_recursive({{"a", "\\x.b x"}, {"b", "\\x.c a"}, {"c", "\\x.b x"}});
+    REQUIRE(nested[0].find_first_of("abc") == std::string::npos);
+    REQUIRE(nested[1] == convert("\\x.c a"));
+    REQUIRE(nested[2].find_first_of("bc") == std::string::npos);
+    REQUIRE(nested[2].find('a') != std::string::npos);
+}
+
 // TEST_CASE("SKI conversion", "[ski]") {
 //     REQUIRE(convert("\\x.x") == "I");
 //     REQUIRE(convert("\\x.\\y.x") == "K");
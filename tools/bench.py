@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+"""Prints the applications per printed character of the recursion benchmarks.
+
+    python3 tools/bench.py build/relambda examples/bench_*.rl
+
+Each program is compiled with relambda and run by tools/unlambda.py twice, stopping after --skip characters and after
+--skip + --count characters. The difference is divided by --count, so the setup before the loop is not counted.
+"""
+
+import argparse
+import pathlib
+import re
+import subprocess
+import sys
+
+UNLAMBDA = pathlib.Path(__file__).with_name("unlambda.py")
+
+
+def applications(program, max_output):
+    res = subprocess.run(
+        [sys.executable, UNLAMBDA, "--force", "--max-output", str(max_output)],
+        input=program,
+        capture_output=True,
+        text=True,
+        check=True,
+    )
+    return int(re.search(r"applications: (\d+)", res.stderr).group(1))
+
+
+def main():
+    args = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    args.add_argument("relambda", help="path to the relambda executable")
+    args.add_argument("sources", nargs="+", help="benchmark programs")
+    args.add_argument("--skip", type=int, default=10, help="characters printed before counting")
+    args.add_argument("--count", type=int, default=2, help="characters to count, even for mutual recursion")
+    args = args.parse_args()
+
+    for source in args.sources:
+        program = subprocess.run([args.relambda, source], capture_output=True, text=True, check=True).stdout
+        before = applications(program, args.skip)
+        after = applications(program, args.skip + args.count)
+        print(f"{source}: {(after - before) / args.count:g}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Reference Unlambda interpreter for the subset relambda emits (s, k, i, v, d and .x).
+
+Reads a program from stdin, prints its output and reports the number of applications on stderr.
+
+    relambda examples/recursion.rl | python3 tools/unlambda.py --force --max-output 3
+
+--force applies the result to i, which is needed because relambda wraps main in a thunk.
+--max-output stops after that many characters are printed, so infinite loops can be measured.
+"""
+
+import argparse
+import sys
+import threading
+
+
+class Stop(Exception):
+    pass
+
+
+class Interpreter:
+    def __init__(self, max_output):
+        self.max_output = max_output
+        self.output = []
+        self.applications = 0
+
+    # Expressions and functions are tuples tagged by their first element. Promises made by d hold a callable.
+    def eval(self, expr):
+        if expr[0] == "`":
+            fun = self.eval(expr[1])
+            if fun == ("d",):
+                return ("d1", lambda: self.eval(expr[2]))
+            return self.apply(fun, self.eval(expr[2]))
+        return expr
+
+    def apply(self, fun, arg):
+        self.applications += 1
+        tag = fun[0]
+        if tag == "i":
+            return arg
+        if tag == "v":
+            return fun
+        if tag == "k":
+            return ("k1", arg)
+        if tag == "k1":
+            return fun[1]
+        if tag == "s":
+            return ("s1", arg)
+        if tag == "s1":
+            return ("s2", fun[1], arg)
+        if tag == "s2":
+            # ```sXYZ is ``XZ`YZ, so `YZ stays unevaluated when `XZ is d
+            lhs = self.apply(fun[1], arg)
+            if lhs == ("d",):
+                return ("d1", lambda: self.apply(fun[2], arg))
+            return self.apply(lhs, self.apply(fun[2], arg))
+        if tag == "d":
+            return ("d1", lambda: arg)
+        if tag == "d1":
+            # promises are not memoized, the delayed expression is evaluated every time
+            return self.apply(fun[1](), arg)
+        if tag == ".":
+            self.output.append(fun[1])
+            if len(self.output) >= self.max_output:
+                raise Stop
+            return arg
+        raise ValueError(f"unknown function {tag}")
+
+
+def parse(src):
+    pos = 0
+
+    def expr():
+        nonlocal pos
+        while src[pos].isspace():
+            pos += 1
+        c = src[pos]
+        pos += 1
+        if c == "`":
+            lhs = expr()
+            return ("`", lhs, expr())
+        if c == ".":
+            pos += 1
+            return (".", src[pos - 1])
+        return (c,)
+
+    return expr()
+
+
+def main():
+    args = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    args.add_argument("--force", action="store_true", help="apply the result to i")
+    args.add_argument("--max-output", type=int, default=sys.maxsize, help="stop after printing this many characters")
+    args = args.parse_args()
+
+    interpreter = Interpreter(args.max_output)
+    try:
+        res = interpreter.eval(parse(sys.stdin.read()))
+        if args.force:
+            interpreter.apply(res, ("i",))
+    except Stop:
+        pass
+    print("".join(interpreter.output))
+    print("applications:", interpreter.applications, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    # evaluation recurses as deep as the program does
+    sys.setrecursionlimit(1_000_000)
+    threading.stack_size(512 * 1024 * 1024)
+    thread = threading.Thread(target=main)
+    thread.start()
+    thread.join()